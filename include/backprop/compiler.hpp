@@ -0,0 +1,348 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdlib>
+#include <type_traits>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "graph.hpp"
+/*
+Graph compiler
+
+Lowers a captured graph into straight-line C++, compiles it into a shared object with the
+local compiler and loads it with dlopen. Values and gradients live in flat arrays indexed by
+slot, so running the graph costs no virtual calls or pointer chasing.
+
+*/
+
+namespace backprop{
+
+/**
+ * @brief A graph compiled into native forward and backward kernels.
+ *
+ * The graph is captured once at construction, later runs reuse the same kernels and only
+ * reload the values of the leaf tensors. Unless disabled the captured graph is first run
+ * through Graph::optimize, so constants are inlined and shared subterms computed once.
+ * The compiler used can be overridden with the BACKPROP_JIT_CXX environment variable, it
+ * defaults to c++ and must name a single executable, it is run directly rather than
+ * through a shell.
+ *
+ * Example:
+ *   Tensor<float> loss = ...;
+ *   CompiledGraph<float> compiled(loss);
+ *   compiled.forward();
+ *   loss.grad_ = 1.0;
+ *   compiled.backward();
+ *
+ * @tparam T The data type of the tensor elements (e.g., float, double).
+ */
+template <typename T>
+class CompiledGraph{
+    static_assert(std::is_floating_point<T>::value,
+                    "CompiledGraph only supports floating point tensors");
+    public:
+        /**
+         * @brief Captures the graph behind root and compiles it.
+         *
+         * @param root Tensor at the top of the graph, must outlive the CompiledGraph.
+         * @param optimize Whether to run Graph::optimize before generating code.
+         * @throws std::runtime_error if the generated code fails to compile or load.
+         */
+        explicit CompiledGraph(Tensor<T>& root, bool optimize = true): graph_(root), root_(&root) {
+                if(optimize)
+                    graph_.optimize();
+                values_.assign(graph_.size(), 0);
+                grads_.assign(graph_.size(), 0);
+                for(size_t i = 0; i < graph_.size(); i++){
+                    if(graph_.nodes[i].constant)
+                        values_[i] = graph_.nodes[i].value;
+                }
+                source_ = generate_source();
+                try{
+                    load();
+                }
+                catch(...){
+                    release();
+                    throw;
+                }
+            }
+
+        ~CompiledGraph(){
+            release();
+        }
+
+        CompiledGraph(const CompiledGraph&) = delete;
+        CompiledGraph& operator=(const CompiledGraph&) = delete;
+
+        /**
+         * @brief Recomputes every node from the current values of the leaf tensors.
+         *
+         * The results are written back into the bound tensors and the aliases left by
+         * Graph::optimize, equivalent to calling forward() on every Function in topological
+         * order. Only a tensor removed outright by the optimizer keeps its old value.
+         */
+        void forward(){
+            for(size_t i = 0; i < graph_.size(); i++){
+                if(graph_.nodes[i].leaf && !graph_.nodes[i].constant)
+                    values_[i] = graph_.nodes[i].tensor->item();
+            }
+            run_forward();
+            for(const auto& [tensor, slot] : graph_.bindings()){
+                tensor->set(values_[slot]);
+            }
+            for(const auto& [tensor, slot] : graph_.aliases()){
+                tensor->set(values_[slot]);
+            }
+        }
+
+        /**
+         * @brief Backpropagates the gradient currently set on the root tensor.
+         *
+         * Like Tensor::backward, the gradients are accumulated into grad_ of every
+         * captured tensor other than the root. When the graph was optimized only the
+         * tensors still bound after Graph::optimize are updated: leaf gradients match the
+         * interpreter, a tensor kept for a merged node gets the gradient of every use, and
+         * aliases (merged away or folded tensors) are left untouched so no gradient is
+         * counted twice.
+         * REQUIRES: forward() or the interpreted graph has computed the current values
+         */
+        void backward(){
+            std::fill(grads_.begin(), grads_.end(), 0);
+            grads_[graph_.output] = root_->grad_;
+            run_backward();
+            for(const auto& [tensor, slot] : graph_.bindings()){
+                if(tensor != root_)
+                    tensor->grad_ += grads_[slot];
+            }
+        }
+
+        // Runs the forward kernel on the value registers only
+        void run_forward(){
+            forward_kernel_(values_.data());
+        }
+
+        // Runs the backward kernel on the registers only, grads() must be seeded beforehand
+        void run_backward(){
+            backward_kernel_(values_.data(), grads_.data());
+        }
+
+        std::vector<T>& values(){
+            return values_;
+        }
+
+        std::vector<T>& grads(){
+            return grads_;
+        }
+
+        const Graph<T>& graph() const{
+            return graph_;
+        }
+
+        // The generated C++ source, useful for debugging
+        const std::string& source() const{
+            return source_;
+        }
+
+    protected:
+        using ForwardKernel = void (*)(T*);
+        using BackwardKernel = void (*)(const T*, T*);
+
+        Graph<T> graph_;
+        Tensor<T>* root_;
+        std::vector<T> values_;
+        std::vector<T> grads_;
+        std::string source_;
+        std::filesystem::path work_dir_;
+        void* handle_ = nullptr;
+        ForwardKernel forward_kernel_ = nullptr;
+        BackwardKernel backward_kernel_ = nullptr;
+
+        static const char* type_name(){
+            if constexpr (std::is_same<T, float>::value)
+                return "float";
+            else if constexpr (std::is_same<T, double>::value)
+                return "double";
+            else
+                return "long double";
+        }
+
+        // Constants are inlined as exact hex float literals, everything else reads its register
+        std::string value(size_t slot) const{
+            const GraphNode<T>& node = graph_.nodes[slot];
+            if(node.constant && std::isfinite(node.value)){
+                std::ostringstream literal;
+                literal << "(" << std::hexfloat << node.value;
+                if constexpr (std::is_same<T, float>::value)
+                    literal << "f";
+                else if constexpr (std::is_same<T, long double>::value)
+                    literal << "L";
+                literal << ")";
+                return literal.str();
+            }
+            return "v[" + std::to_string(slot) + "]";
+        }
+
+        static std::string grad(size_t slot){
+            return "g[" + std::to_string(slot) + "]";
+        }
+
+        std::string generate_source() const{
+            const std::string type = type_name();
+            std::ostringstream src;
+            src << "#include <cmath>\n\n";
+
+            src << "extern \"C\" void bp_forward(" << type << "* v){\n";
+            for(size_t i = 0; i < graph_.size(); i++){
+                const GraphNode<T>& node = graph_.nodes[i];
+                if(node.leaf)
+                    continue;
+                src << "    " << value(i) << " = ";
+                switch(node.op){
+                    case OpType::Add:
+                        src << value(node.inputs[0]) << " + " << value(node.inputs[1]);
+                        break;
+                    case OpType::Subtract:
+                        src << value(node.inputs[0]) << " - " << value(node.inputs[1]);
+                        break;
+                    case OpType::Multiply:
+                        src << value(node.inputs[0]) << " * " << value(node.inputs[1]);
+                        break;
+                    case OpType::Tanh:
+                        src << "std::tanh(" << value(node.inputs[0]) << ")";
+                        break;
+                }
+                src << ";\n";
+            }
+            src << "}\n\n";
+
+            // Gradients flow from the output back towards the leaves, so walk the
+            // topological order in reverse. Constants never need a gradient.
+            src << "extern \"C\" void bp_backward(const " << type << "* v, " << type << "* g){\n";
+            auto accumulate = [&](size_t input, const char* op, const std::string& expr){
+                if(!graph_.nodes[input].constant)
+                    src << "    " << grad(input) << " " << op << " " << expr << ";\n";
+            };
+            for(size_t i = graph_.size(); i-- > 0;){
+                const GraphNode<T>& node = graph_.nodes[i];
+                if(node.leaf)
+                    continue;
+                switch(node.op){
+                    case OpType::Add:
+                        accumulate(node.inputs[0], "+=", grad(i));
+                        accumulate(node.inputs[1], "+=", grad(i));
+                        break;
+                    case OpType::Subtract:
+                        accumulate(node.inputs[0], "+=", grad(i));
+                        accumulate(node.inputs[1], "-=", grad(i));
+                        break;
+                    case OpType::Multiply:
+                        accumulate(node.inputs[0], "+=", grad(i) + " * " + value(node.inputs[1]));
+                        accumulate(node.inputs[1], "+=", grad(i) + " * " + value(node.inputs[0]));
+                        break;
+                    case OpType::Tanh:
+                        accumulate(node.inputs[0], "+=",
+                            grad(i) + " * (1 - " + value(i) + " * " + value(i) + ")");
+                        break;
+                }
+            }
+            src << "}\n";
+            return src.str();
+        }
+
+        void release(){
+            if(handle_ != nullptr)
+                dlclose(handle_);
+            handle_ = nullptr;
+            if(!work_dir_.empty()){
+                std::error_code ec;
+                std::filesystem::remove_all(work_dir_, ec);
+            }
+        }
+
+        /**
+         * @brief Runs the compiler directly, without a shell, with its output sent to log_path.
+         *
+         * cxx is a single executable looked up on PATH, it is never split or interpreted so
+         * neither it nor the temp directory can inject commands.
+         *
+         * @return The exit status of the compiler, or -1 if it could not be run.
+         */
+        static int run_compiler(const std::string& cxx, const std::filesystem::path& src_path,
+            const std::filesystem::path& lib_path, const std::filesystem::path& log_path){
+            std::vector<std::string> args = {cxx, "-O2", "-std=c++17", "-shared", "-fPIC",
+                "-o", lib_path.string(), src_path.string()};
+            std::vector<char*> argv;
+            for(std::string& arg : args)
+                argv.push_back(arg.data());
+            argv.push_back(nullptr);
+
+            int log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if(log_fd < 0)
+                return -1;
+            pid_t pid = fork();
+            if(pid == 0){
+                dup2(log_fd, STDOUT_FILENO);
+                dup2(log_fd, STDERR_FILENO);
+                execvp(argv[0], argv.data());
+                _exit(127);
+            }
+            close(log_fd);
+            if(pid < 0)
+                return -1;
+            int status = 0;
+            while(waitpid(pid, &status, 0) < 0){
+                if(errno != EINTR)
+                    return -1;
+            }
+            return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        }
+
+        // Writes the source to a private temp directory, compiles it and resolves the kernels
+        void load(){
+            // mkdtemp creates the directory with mode 0700 and fails rather than reusing an
+            // existing path, so nobody else can swap the library before it is loaded
+            std::string dir_template =
+                (std::filesystem::temp_directory_path() / "backprop_jit_XXXXXX").string();
+            if(mkdtemp(dir_template.data()) == nullptr){
+                throw std::runtime_error(std::string("CompiledGraph: failed to create work directory: ") +
+                    std::strerror(errno));
+            }
+            work_dir_ = dir_template;
+            std::filesystem::path src_path = work_dir_ / "kernel.cpp";
+            std::filesystem::path lib_path = work_dir_ / "kernel.so";
+            std::filesystem::path log_path = work_dir_ / "compile.log";
+            {
+                std::ofstream out(src_path);
+                out << source_;
+            }
+
+            const char* env_cxx = std::getenv("BACKPROP_JIT_CXX");
+            std::string cxx = env_cxx != nullptr && *env_cxx != '\0' ? env_cxx : "c++";
+            if(run_compiler(cxx, src_path, lib_path, log_path) != 0){
+                std::ifstream log(log_path);
+                std::stringstream msg;
+                msg << "CompiledGraph: failed to compile kernel with " << cxx << "\n" << log.rdbuf();
+                throw std::runtime_error(msg.str());
+            }
+
+            handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if(handle_ == nullptr)
+                throw std::runtime_error(std::string("CompiledGraph: dlopen failed: ") + dlerror());
+            forward_kernel_ = reinterpret_cast<ForwardKernel>(dlsym(handle_, "bp_forward"));
+            backward_kernel_ = reinterpret_cast<BackwardKernel>(dlsym(handle_, "bp_backward"));
+            if(forward_kernel_ == nullptr || backward_kernel_ == nullptr)
+                throw std::runtime_error("CompiledGraph: kernel symbols missing from compiled library");
+        }
+};
+
+}
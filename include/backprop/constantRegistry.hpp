@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
 #include <unordered_map>
+#include <memory>
+
+#include "memory.hpp"
 
 namespace backprop{
 
@@ -23,9 +26,17 @@ public:
         
         auto tensor = std::make_unique<backprop::Tensor<T>>(value);
         backprop::Tensor<T>* ptr = tensor.get();
+        // constants are never freed, keep them out of the step leak checks
+        MemoryTracker<T>::constant_created();
         constants_[value] = std::move(tensor);
         return ptr;
     }
+
+    // Returns true if t is one of the tensors owned by the registry
+    static bool is_constant(const backprop::Tensor<T>* t) {
+        auto it = constants_.find(t->item());
+        return it != constants_.end() && it->second.get() == t;
+    }
 };
 
 template<typename T>
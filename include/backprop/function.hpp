@@ -2,6 +2,9 @@
 #include <vector>
 #include <cassert>
 #include <memory>
+#include <cmath>
+
+#include "memory.hpp"
 /*
 Jun 8 2025
 Alex Bowler
@@ -15,6 +18,19 @@ namespace backprop{
 template <typename T>
 class Tensor;
 
+/**
+ * @brief Identifies which operation a Function performs.
+ * 
+ * Used by passes which inspect the recorded graph (e.g. the graph compiler) to tell
+ * operations apart without relying on dynamic_cast.
+ */
+enum class OpType{
+    Add,
+    Subtract,
+    Multiply,
+    Tanh
+};
+
 /**
  * @brief Base Function class to be inherited by specific operation functions.
  * 
@@ -33,6 +49,30 @@ class Function{
         Tensor<T>* output_ = nullptr;
         virtual void backward() = 0;  
         virtual void forward() = 0;
+        virtual OpType type() const = 0;
+
+        Function(){
+            MemoryTracker<T>::function_created();
+        }
+
+        // Functions are referenced by pointer from the graph, copies would be left dangling
+        Function(const Function&) = delete;
+        Function& operator=(const Function&) = delete;
+
+        virtual ~Function(){
+            MemoryTracker<T>::saved_removed(recorded_saved_bytes_);
+            MemoryTracker<T>::function_destroyed();
+        }
+
+        /**
+         * @brief Bytes this function keeps alive for the backward pass.
+         * 
+         * Counts the function object itself and its list of parents, the parent tensors
+         * are owned elsewhere and are not included.
+         */
+        size_t saved_bytes() const{
+            return sizeof(Function<T>) + this->parents.capacity() * sizeof(Tensor<T>*);
+        }
 
         /**
          * @brief Sets the pointer to the tensor that this function created.
@@ -46,7 +86,15 @@ class Function{
          */
         void set_output_tensor(Tensor<T>* o){
             this->output_ = o;
+            // parents are final once the function is attached, so account for them here
+            MemoryTracker<T>::saved_removed(recorded_saved_bytes_);
+            recorded_saved_bytes_ = saved_bytes();
+            MemoryTracker<T>::saved_added(recorded_saved_bytes_);
         }
+
+    protected:
+        // saved_bytes() as last reported to MemoryTracker
+        size_t recorded_saved_bytes_ = 0;
 };
 
 /**
@@ -88,7 +136,56 @@ class AddFunction: public Function<T>{
         assert(this->output_ != nullptr);
         this->output_->set(this->parents[0]->item() + this->parents[1]->item());
     }
+
+    OpType type() const override {
+        return OpType::Add;
+    }
+};
+/**
+ * @brief Function representing element-wise subtraction of two tensors.
+ * 
+ * The SubtractFunction class implements the subtraction operation in the computation graph.
+ * It stores pointers to the two parent tensors, the second being subtracted from the first.
+ * During backpropagation the output gradient is added to the first parent and subtracted
+ * from the second, since d/dx (x - y) = 1 and d/dy (x - y) = -1.
+ * 
+ * @tparam T The data type of the tensor elements (e.g., float, double).
+ */
+template <typename T>
+class SubtractFunction: public Function<T>{
+    public:
+    /**
+     * @brief Constructs a SubtractFunction with two parent tensors.
+     * 
+     * @param a Pointer to the tensor being subtracted from.
+     * @param b Pointer to the tensor being subtracted.
+     */
+    SubtractFunction(Tensor<T>* a, Tensor<T>* b){
+        this->parents = {a, b};
+    }
+
+    /**
+     * @brief Backward pass for the subtraction operation.
+     * 
+     * Adds the output gradient to the first parent and subtracts it from the second.
+     * 
+     */
+    void backward() override {
+        assert(this->output_ != nullptr);
+        this->parents[0]->grad_ += this->output_->grad_;
+        this->parents[1]->grad_ -= this->output_->grad_;
+    }
+
+    void forward() override {
+        assert(this->output_ != nullptr);
+        this->output_->set(this->parents[0]->item() - this->parents[1]->item());
+    }
+
+    OpType type() const override {
+        return OpType::Subtract;
+    }
 };
+
 /**
  * @brief Function representing element-wise multiplication of two tensors.
  * 
@@ -141,6 +238,10 @@ class MultiplyFunction : public Function<T>{
         assert(this->output_ != nullptr);
         this->output_->set(this->parents[0]->item()*this->parents[1]->item());
     }
+
+    OpType type() const override {
+        return OpType::Multiply;
+    }
 };
 
 /**
@@ -181,14 +282,16 @@ class TanhFunction : public Function<T>{
     /**
      * @brief Forward pass of tanh operation
      * 
-     * Calculates the forward operation of tanh currently for testing purposes
+     * Calculates the forward operation of tanh currently for testing purposes.
+     * Uses std::tanh, which saturates to +-1 instead of overflowing for large inputs.
      */
     void forward() override{
         assert(this->output_ != nullptr);
-        T data = this->parents[0]->item();
-        T pos_exp = std::exp(data);
-        T neg_exp = std::exp(-1*data);
-        this->output_->set((pos_exp-neg_exp)/(pos_exp+neg_exp));
+        this->output_->set(std::tanh(this->parents[0]->item()));
+    }
+
+    OpType type() const override {
+        return OpType::Tanh;
     }
 };
 
@@ -0,0 +1,302 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include "tensor.hpp"
+/*
+Captured computation graphs
+
+Flattens the graph recorded behind a tensor into a topologically ordered list of nodes
+addressed by slot index, so it can be inspected, optimized or lowered without chasing
+parent pointers.
+
+*/
+
+namespace backprop{
+
+/**
+ * @brief A single node of a captured graph.
+ *
+ * Leaves are tensors without a grad_fn, their values are read from the backing tensor
+ * each time the graph is run. Constant leaves (ConstantRegistry tensors and folded
+ * subgraphs) instead carry their value. Every other node applies op to the slots in inputs.
+ *
+ * @tparam T The data type of the tensor elements (e.g., float, double).
+ */
+template <typename T>
+struct GraphNode{
+    // operation producing this node, meaningless for leaves
+    OpType op = OpType::Add;
+    // slots of the nodes this node reads from
+    std::vector<size_t> inputs;
+    // true for tensors without a grad_fn
+    bool leaf = false;
+    // true for leaves whose value is known when the graph is optimized
+    bool constant = false;
+    // value of a constant leaf
+    T value = 0;
+    // tensor this node was captured from, Note does not pass ownership
+    Tensor<T>* tensor = nullptr;
+};
+
+/**
+ * @brief Topologically ordered snapshot of the graph behind a tensor.
+ *
+ * Each node gets a slot equal to its index in nodes, parents always come before the
+ * nodes that use them. The captured tensors must outlive the Graph.
+ *
+ * @tparam T The data type of the tensor elements (e.g., float, double).
+ */
+template <typename T>
+class Graph{
+    public:
+        std::vector<GraphNode<T>> nodes;
+        // slot holding the value of the tensor the graph was captured from
+        size_t output = 0;
+
+        /**
+         * @brief Captures the graph which produced root.
+         *
+         * @param root Tensor at the top of the graph, usually the loss.
+         */
+        explicit Graph(Tensor<T>& root){
+            capture_recursive(&root);
+            output = slots_.at(&root);
+        }
+
+        size_t size() const{
+            return nodes.size();
+        }
+
+        // Returns true if t is bound to a slot of the graph
+        bool contains(Tensor<T>* t) const{
+            return slots_.count(t) != 0;
+        }
+
+        // Returns the slot a captured tensor lives in
+        size_t slot(Tensor<T>* t) const{
+            return slots_.at(t);
+        }
+
+        /**
+         * @brief Optimizes the captured graph in place.
+         *
+         * Runs a single pass in topological order which
+         *   - folds nodes whose inputs are all constants into a constant leaf,
+         *   - rewrites a + (b * -1) into a - b,
+         *   - hash-conses identical (op, inputs) pairs so shared subterms are computed once,
+         * followed by removing every node the output no longer depends on.
+         *
+         * Only one tensor stays bound to each remaining op node, the first one captured. It
+         * receives the gradient of every use of the merged node. Tensors which were merged
+         * into another node or folded into a constant become aliases of the slot replacing
+         * them, a CompiledGraph writes their values but never their gradients. Tensors whose
+         * node was removed outright (like the b * -1 of a rewritten subtraction) are neither
+         * bound nor aliased; leaves are unaffected.
+         *
+         * @return The number of nodes removed from the graph.
+         */
+        size_t optimize(){
+            size_t original_size = nodes.size();
+            std::vector<GraphNode<T>> optimized;
+            // maps every old slot to the slot of its replacement in optimized
+            std::vector<size_t> remap(nodes.size());
+            std::map<std::pair<OpType, std::vector<size_t>>, size_t> ops;
+            std::map<T, size_t> constants;
+
+            auto add_constant = [&](T value, Tensor<T>* tensor){
+                // non finite values can't be ordered, so they are never shared
+                if(std::isfinite(value)){
+                    auto it = constants.find(value);
+                    if(it != constants.end())
+                        return it->second;
+                }
+                GraphNode<T> node;
+                node.leaf = true;
+                node.constant = true;
+                node.value = value;
+                node.tensor = tensor;
+                optimized.push_back(node);
+                if(std::isfinite(value))
+                    constants[value] = optimized.size() - 1;
+                return optimized.size() - 1;
+            };
+
+            auto is_negation = [&](size_t slot, size_t& negated){
+                const GraphNode<T>& node = optimized[slot];
+                if(node.leaf || node.op != OpType::Multiply)
+                    return false;
+                for(size_t i = 0; i < 2; i++){
+                    const GraphNode<T>& factor = optimized[node.inputs[i]];
+                    if(factor.constant && factor.value == static_cast<T>(-1)){
+                        negated = node.inputs[1 - i];
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            for(size_t i = 0; i < nodes.size(); i++){
+                GraphNode<T> node = nodes[i];
+                if(node.leaf){
+                    if(node.constant){
+                        remap[i] = add_constant(node.value, node.tensor);
+                    }
+                    else if(ConstantRegistry<T>::is_constant(node.tensor)){
+                        remap[i] = add_constant(node.tensor->item(), node.tensor);
+                    }
+                    else{
+                        optimized.push_back(node);
+                        remap[i] = optimized.size() - 1;
+                    }
+                    continue;
+                }
+
+                bool all_constant = true;
+                for(size_t& input : node.inputs){
+                    input = remap[input];
+                    all_constant = all_constant && optimized[input].constant;
+                }
+                if(all_constant){
+                    remap[i] = add_constant(evaluate(node, optimized), node.tensor);
+                    continue;
+                }
+
+                size_t negated;
+                if(node.op == OpType::Add){
+                    if(is_negation(node.inputs[1], negated)){
+                        node.op = OpType::Subtract;
+                        node.inputs = {node.inputs[0], negated};
+                    }
+                    else if(is_negation(node.inputs[0], negated)){
+                        node.op = OpType::Subtract;
+                        node.inputs = {node.inputs[1], negated};
+                    }
+                }
+                // x + y and y + x compute the same value
+                if(node.op == OpType::Add || node.op == OpType::Multiply)
+                    std::sort(node.inputs.begin(), node.inputs.end());
+
+                auto key = std::make_pair(node.op, node.inputs);
+                auto it = ops.find(key);
+                if(it != ops.end()){
+                    remap[i] = it->second;
+                    continue;
+                }
+                optimized.push_back(node);
+                remap[i] = optimized.size() - 1;
+                ops[key] = remap[i];
+            }
+
+            // Drop everything the output no longer depends on, walking backwards so that
+            // users are visited before their inputs
+            size_t new_output = remap[output];
+            std::vector<bool> live(optimized.size(), false);
+            live[new_output] = true;
+            for(size_t i = optimized.size(); i-- > 0;){
+                if(!live[i])
+                    continue;
+                for(size_t input : optimized[i].inputs)
+                    live[input] = true;
+            }
+            std::vector<size_t> compacted(optimized.size());
+            nodes.clear();
+            for(size_t i = 0; i < optimized.size(); i++){
+                if(!live[i])
+                    continue;
+                for(size_t& input : optimized[i].inputs)
+                    input = compacted[input];
+                compacted[i] = nodes.size();
+                nodes.push_back(std::move(optimized[i]));
+            }
+            output = compacted[new_output];
+
+            std::vector<std::pair<Tensor<T>*, size_t>> bindings;
+            std::vector<std::pair<Tensor<T>*, size_t>> aliases;
+            slots_.clear();
+            for(const auto& [tensor, slot] : bindings_){
+                if(!live[remap[slot]])
+                    continue;
+                size_t new_slot = compacted[remap[slot]];
+                const GraphNode<T>& node = nodes[new_slot];
+                if(node.constant || node.tensor != tensor){
+                    aliases.emplace_back(tensor, new_slot);
+                    continue;
+                }
+                slots_[tensor] = new_slot;
+                bindings.emplace_back(tensor, new_slot);
+            }
+            // aliases from an earlier optimize() follow their slot to its new position
+            for(const auto& [tensor, slot] : aliases_){
+                if(live[remap[slot]])
+                    aliases.emplace_back(tensor, compacted[remap[slot]]);
+            }
+            bindings_ = std::move(bindings);
+            aliases_ = std::move(aliases);
+            return original_size - nodes.size();
+        }
+
+        // Every captured tensor along with its slot, in capture order
+        const std::vector<std::pair<Tensor<T>*, size_t>>& bindings() const{
+            return bindings_;
+        }
+
+        // Tensors optimize() merged or folded into another slot, they share its value only
+        const std::vector<std::pair<Tensor<T>*, size_t>>& aliases() const{
+            return aliases_;
+        }
+
+    protected:
+        std::unordered_map<Tensor<T>*, size_t> slots_;
+        // flat copy of slots_ so that syncing with the tensors is a linear scan
+        std::vector<std::pair<Tensor<T>*, size_t>> bindings_;
+        std::vector<std::pair<Tensor<T>*, size_t>> aliases_;
+
+        // Computes the value of an op node whose inputs are all constants
+        static T evaluate(const GraphNode<T>& node, const std::vector<GraphNode<T>>& graph){
+            const T a = graph[node.inputs[0]].value;
+            switch(node.op){
+                case OpType::Add:
+                    return a + graph[node.inputs[1]].value;
+                case OpType::Subtract:
+                    return a - graph[node.inputs[1]].value;
+                case OpType::Multiply:
+                    return a * graph[node.inputs[1]].value;
+                case OpType::Tanh:
+                    return std::tanh(a);
+            }
+            assert(false);
+            return a;
+        }
+
+        // Post order walk so that every parent is given a slot before its children
+        size_t capture_recursive(Tensor<T>* t){
+            auto it = slots_.find(t);
+            if(it != slots_.end())
+                return it->second;
+
+            GraphNode<T> node;
+            node.tensor = t;
+            if(t->grad_fn_ptr == nullptr){
+                node.leaf = true;
+            }
+            else{
+                node.op = t->grad_fn_ptr->type();
+                for(Tensor<T>* parent : t->grad_fn_ptr->parents){
+                    node.inputs.push_back(capture_recursive(parent));
+                }
+            }
+            size_t slot = nodes.size();
+            nodes.push_back(std::move(node));
+            slots_[t] = slot;
+            bindings_.emplace_back(t, slot);
+            return slot;
+        }
+};
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <ostream>
+#include <string>
+
+#include "graph.hpp"
+#include "memory.hpp"
+/*
+Graph introspection
+
+Reports how many nodes and bytes the graph behind a tensor keeps alive, and dumps it to
+Graphviz DOT with per node sizes. Process wide counters live in MemoryTracker.
+
+*/
+
+namespace backprop{
+
+/**
+ * @brief Node counts and bytes held by a single graph.
+ */
+struct GraphStats{
+    size_t nodes = 0;
+    size_t leaves = 0;
+    size_t functions = 0;
+    size_t value_bytes = 0;
+    size_t grad_bytes = 0;
+    size_t saved_bytes = 0;
+
+    size_t total_bytes() const{
+        return value_bytes + grad_bytes + saved_bytes;
+    }
+};
+
+inline const char* op_name(OpType op){
+    switch(op){
+        case OpType::Add:
+            return "add";
+        case OpType::Subtract:
+            return "sub";
+        case OpType::Multiply:
+            return "mul";
+        case OpType::Tanh:
+            return "tanh";
+    }
+    return "unknown";
+}
+
+// Bytes held by a single captured tensor, its value, gradient and grad_fn
+template <typename T>
+size_t node_bytes(const Tensor<T>& t){
+    size_t bytes = 2 * sizeof(T);
+    if(t.grad_fn_ptr != nullptr)
+        bytes += t.grad_fn_ptr->saved_bytes();
+    return bytes;
+}
+
+/**
+ * @brief Counts the nodes and bytes of the graph which produced root.
+ *
+ * Every tensor reachable from root is counted once, including leaves and
+ * ConstantRegistry constants.
+ */
+template <typename T>
+GraphStats graph_stats(Tensor<T>& root){
+    Graph<T> graph(root);
+    GraphStats stats;
+    stats.nodes = graph.size();
+    for(const GraphNode<T>& node : graph.nodes){
+        stats.value_bytes += sizeof(T);
+        stats.grad_bytes += sizeof(T);
+        if(node.leaf){
+            stats.leaves++;
+        }
+        else{
+            stats.functions++;
+            stats.saved_bytes += node.tensor->grad_fn_ptr->saved_bytes();
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief Writes the graph which produced root to os in Graphviz DOT format.
+ *
+ * Each node is labelled with its operation, value, gradient and the bytes it holds.
+ * Edges point from parents to the nodes which use them.
+ *
+ * Example:
+ *   std::ofstream file("graph.dot");
+ *   to_dot(loss, file);
+ */
+template <typename T>
+void to_dot(Tensor<T>& root, std::ostream& os){
+    Graph<T> graph(root);
+    os << "digraph backprop {\n";
+    os << "    rankdir=BT;\n";
+    for(size_t i = 0; i < graph.size(); i++){
+        const GraphNode<T>& node = graph.nodes[i];
+        const Tensor<T>& t = *node.tensor;
+        std::string kind = node.leaf ?
+            (ConstantRegistry<T>::is_constant(node.tensor) ? "const" : "leaf") : op_name(node.op);
+        os << "    n" << i << " [shape=" << (node.leaf ? "ellipse" : "box")
+           << ", label=\"" << kind
+           << "\\nvalue=" << t.item()
+           << "\\ngrad=" << t.grad_
+           << "\\nbytes=" << node_bytes(t) << "\"];\n";
+    }
+    for(size_t i = 0; i < graph.size(); i++){
+        for(size_t input : graph.nodes[i].inputs){
+            os << "    n" << input << " -> n" << i << ";\n";
+        }
+    }
+    os << "}\n";
+}
+
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+/*
+Memory accounting
+
+Process wide counters of the live Tensors and Functions of each element type, along with
+the bytes they hold. Used to size batches and to catch graphs which outlive a step.
+
+*/
+
+namespace backprop{
+
+/**
+ * @brief Point in time view of the memory held by tensors and functions of one type.
+ */
+struct MemorySnapshot{
+    size_t live_tensors = 0;
+    // live tensors owned by ConstantRegistry, included in live_tensors
+    size_t constant_tensors = 0;
+    size_t live_functions = 0;
+    // bytes holding tensor values
+    size_t value_bytes = 0;
+    // bytes holding tensor gradients
+    size_t grad_bytes = 0;
+    // bytes kept alive by functions for the backward pass, the function objects and
+    // their parent lists
+    size_t saved_bytes = 0;
+    // part of value_bytes and grad_bytes held by ConstantRegistry tensors
+    size_t constant_bytes = 0;
+
+    size_t total_bytes() const{
+        return value_bytes + grad_bytes + saved_bytes;
+    }
+
+    // total_bytes() without the ConstantRegistry tensors, which live for the whole program
+    size_t graph_bytes() const{
+        return total_bytes() - constant_bytes;
+    }
+};
+
+/**
+ * @brief Summary of a step delimited by MemoryTracker::begin_step and end_step.
+ *
+ * The deltas are the number of tensors / functions still alive at the end of the step
+ * which did not exist at its start. Anything positive means the step retained part of
+ * its graph. ConstantRegistry tensors are never freed, so constants first created
+ * during the step are left out of the deltas.
+ */
+struct StepReport{
+    // highest total_bytes() seen during the step
+    size_t peak_bytes = 0;
+    long long tensor_delta = 0;
+    long long function_delta = 0;
+    long long byte_delta = 0;
+
+    bool leaked() const{
+        return tensor_delta > 0 || function_delta > 0;
+    }
+};
+
+/**
+ * @brief Counts live tensors and functions and tracks the peak memory they hold.
+ *
+ * Counters are updated automatically by Tensor and Function. Steps are meant to be
+ * delimited by a single thread, the counters themselves are safe to update from any thread.
+ *
+ * Example:
+ *   MemoryTracker<float>::begin_step();
+ *   ... build the graph, forward, backward ...
+ *   StepReport report = MemoryTracker<float>::end_step();
+ *   if(report.leaked()) ...
+ *
+ * @tparam T The data type of the tensor elements (e.g., float, double).
+ */
+template <typename T>
+class MemoryTracker{
+    private:
+        static std::atomic<size_t> live_tensors_;
+        static std::atomic<size_t> constant_tensors_;
+        static std::atomic<size_t> live_functions_;
+        static std::atomic<size_t> saved_bytes_;
+        static std::atomic<size_t> peak_bytes_;
+        static MemorySnapshot step_start_;
+
+        static size_t current_bytes(){
+            return live_tensors_.load(std::memory_order_relaxed) * 2 * sizeof(T) +
+                saved_bytes_.load(std::memory_order_relaxed);
+        }
+
+        static void update_peak(){
+            size_t current = current_bytes();
+            size_t peak = peak_bytes_.load(std::memory_order_relaxed);
+            while(current > peak &&
+                !peak_bytes_.compare_exchange_weak(peak, current, std::memory_order_relaxed)){
+            }
+        }
+
+    public:
+        static void tensor_created(){
+            live_tensors_.fetch_add(1, std::memory_order_relaxed);
+            update_peak();
+        }
+
+        static void tensor_destroyed(){
+            live_tensors_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Called by ConstantRegistry for the tensors it owns, on top of tensor_created
+        static void constant_created(){
+            constant_tensors_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static void function_created(){
+            live_functions_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static void function_destroyed(){
+            live_functions_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        static void saved_added(size_t bytes){
+            saved_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            update_peak();
+        }
+
+        static void saved_removed(size_t bytes){
+            saved_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        static MemorySnapshot snapshot(){
+            MemorySnapshot snap;
+            snap.live_tensors = live_tensors_.load(std::memory_order_relaxed);
+            snap.constant_tensors = constant_tensors_.load(std::memory_order_relaxed);
+            snap.live_functions = live_functions_.load(std::memory_order_relaxed);
+            snap.value_bytes = snap.live_tensors * sizeof(T);
+            snap.grad_bytes = snap.live_tensors * sizeof(T);
+            snap.saved_bytes = saved_bytes_.load(std::memory_order_relaxed);
+            snap.constant_bytes = snap.constant_tensors * 2 * sizeof(T);
+            return snap;
+        }
+
+        // Highest total bytes seen since the current step began, or since startup
+        static size_t peak_bytes(){
+            return peak_bytes_.load(std::memory_order_relaxed);
+        }
+
+        // Starts a new step, resetting the peak watermark to the current usage
+        static void begin_step(){
+            step_start_ = snapshot();
+            peak_bytes_.store(step_start_.total_bytes(), std::memory_order_relaxed);
+        }
+
+        // Ends the current step, reporting its peak and whatever it left alive
+        static StepReport end_step(){
+            MemorySnapshot end = snapshot();
+            StepReport report;
+            report.peak_bytes = peak_bytes();
+            report.tensor_delta =
+                static_cast<long long>(end.live_tensors - end.constant_tensors) -
+                static_cast<long long>(step_start_.live_tensors - step_start_.constant_tensors);
+            report.function_delta = static_cast<long long>(end.live_functions) -
+                static_cast<long long>(step_start_.live_functions);
+            report.byte_delta = static_cast<long long>(end.graph_bytes()) -
+                static_cast<long long>(step_start_.graph_bytes());
+            return report;
+        }
+};
+
+template<typename T>
+std::atomic<size_t> MemoryTracker<T>::live_tensors_{0};
+template<typename T>
+std::atomic<size_t> MemoryTracker<T>::constant_tensors_{0};
+template<typename T>
+std::atomic<size_t> MemoryTracker<T>::live_functions_{0};
+template<typename T>
+std::atomic<size_t> MemoryTracker<T>::saved_bytes_{0};
+template<typename T>
+std::atomic<size_t> MemoryTracker<T>::peak_bytes_{0};
+template<typename T>
+MemorySnapshot MemoryTracker<T>::step_start_;
+
+/**
+ * @brief Member which keeps the live tensor count of MemoryTracker in sync.
+ *
+ * Embedding it lets Tensor keep its implicit copy and move operations, each constructed
+ * copy counts as a new live tensor.
+ */
+template <typename T>
+class TensorCounter{
+    public:
+        TensorCounter(){
+            MemoryTracker<T>::tensor_created();
+        }
+        TensorCounter(const TensorCounter&){
+            MemoryTracker<T>::tensor_created();
+        }
+        TensorCounter& operator=(const TensorCounter&){
+            return *this;
+        }
+        ~TensorCounter(){
+            MemoryTracker<T>::tensor_destroyed();
+        }
+};
+
+}
@@ -10,6 +10,7 @@
 
 #include "function.hpp"
 #include "constantRegistry.hpp"
+#include "memory.hpp"
 
 
 namespace backprop{
@@ -79,6 +80,8 @@ class Tensor{
     protected:
         T data_;
         std::vector<int> shape_;
+        // keeps MemoryTracker's live tensor count in sync
+        [[no_unique_address]] TensorCounter<T> counter_;
 
         // Builds a topological graph for backpropogation
         void build_topograph(
@@ -157,11 +160,7 @@ Tensor<T> operator*(U val, Tensor<T>& rhs){
 
 template <typename T>
 Tensor<T> tanh(Tensor<T>& t){
-    T data = t.item();
-    T pos_exp = std::exp(data);
-    T neg_exp = std::exp(-1*data);
-    return Tensor<T>((pos_exp-neg_exp)/(pos_exp+neg_exp), 
-                    std::make_shared<TanhFunction<T>>(&t));
+    return Tensor<T>(std::tanh(t.item()), std::make_shared<TanhFunction<T>>(&t));
 }
 
 template<typename T, typename U>
@@ -169,7 +168,7 @@ Tensor<T> operator-(Tensor<T>& lfs, Tensor<U>& rhs){
     static_assert(std::is_same<T, U>::value, 
                     "Cannot subtract tensors of two different data types");
     
-    return lfs + (rhs * static_cast<T>(-1.0));
+    return Tensor<T>(lfs.item() - rhs.item(), std::make_shared<SubtractFunction<T>>(&lfs, &rhs));
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "backprop/tensor.hpp"
+#include "backprop/graph.hpp"
+#include "backprop/compiler.hpp"
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+/*
+Benchmarks running a small fixed graph through the interpreter (virtual forward()/backward()
+calls on every Function) against the same graph compiled into straight-line kernels.
+
+The graph is a two layer network of tanh neurons summed into a single output.
+*/
+
+using Tensor = backprop::Tensor<float>;
+
+// Tensors are referenced by raw pointer from the graph, so they are heap allocated and
+// initialised in place to keep grad_fn->output_ pointing at them
+std::vector<std::unique_ptr<Tensor>> pool;
+
+Tensor& keep(Tensor* t){
+    pool.emplace_back(t);
+    return *t;
+}
+
+Tensor& neuron(const std::vector<Tensor*>& inputs){
+    Tensor* acc = &keep(new Tensor(0.1f));
+    for(size_t i = 0; i < inputs.size(); i++){
+        Tensor& w = keep(new Tensor(0.05f * static_cast<float>(i % 7) - 0.15f));
+        Tensor& wx = keep(new Tensor(w * *inputs[i]));
+        acc = &keep(new Tensor(*acc + wx));
+    }
+    return keep(new Tensor(backprop::tanh(*acc)));
+}
+
+int main(){
+    const int inputs = 8;
+    const int hidden = 8;
+    const int iterations = 100000;
+
+    std::vector<Tensor*> x;
+    for(int i = 0; i < inputs; i++){
+        x.push_back(&keep(new Tensor(0.1f * static_cast<float>(i))));
+    }
+    std::vector<Tensor*> layer1;
+    for(int i = 0; i < hidden; i++){
+        layer1.push_back(&neuron(x));
+    }
+    std::vector<Tensor*> layer2;
+    for(int i = 0; i < hidden; i++){
+        layer2.push_back(&neuron(layer1));
+    }
+    Tensor* out = layer2[0];
+    for(int i = 1; i < hidden; i++){
+        out = &keep(new Tensor(*out + *layer2[i]));
+    }
+
+    backprop::Graph<float> graph(*out);
+    std::cout << "Graph nodes: " << graph.size() << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    backprop::CompiledGraph<float> compiled(*out);
+    auto compile_time = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Compile time: " << compile_time << " ms\n";
+    std::cout << "Optimized nodes: " << compiled.graph().size() << "\n";
+
+    auto time = [&](auto&& step){
+        auto begin = std::chrono::steady_clock::now();
+        for(int it = 0; it < iterations; it++){
+            step();
+        }
+        return std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - begin).count() / iterations;
+    };
+
+    double interpreted = time([&]{
+        for(const backprop::GraphNode<float>& node : graph.nodes){
+            if(!node.leaf)
+                node.tensor->grad_fn_ptr->forward();
+        }
+        out->grad_ = 1.0f;
+        out->backward();
+    });
+    float interpreted_result = out->item();
+
+    double synced = time([&]{
+        compiled.forward();
+        out->grad_ = 1.0f;
+        compiled.backward();
+    });
+
+    double kernels = time([&]{
+        compiled.run_forward();
+        std::fill(compiled.grads().begin(), compiled.grads().end(), 0.0f);
+        compiled.grads()[compiled.graph().output] = 1.0f;
+        compiled.run_backward();
+    });
+
+    std::cout << "Output interpreted " << interpreted_result << " compiled " << out->item() << "\n";
+    std::cout << "Interpreted forward+backward:      " << interpreted << " us\n";
+    std::cout << "Compiled (synced with tensors):    " << synced << " us ("
+              << interpreted / synced << "x)\n";
+    std::cout << "Compiled kernels only:             " << kernels << " us ("
+              << interpreted / kernels << "x)\n";
+    return 0;
+}
@@ -0,0 +1 @@
+#include "backprop/compiler.hpp"
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include "backprop/tensor.hpp"
+#include "backprop/graph.hpp"
+#include "backprop/compiler.hpp"
+
+/*
+Captures: ((4.0 * 5.5) + 2.0) * 3.0
+Leaves come before the nodes which use them
+*/
+TEST(GraphTest, CaptureIsTopological){
+    backprop::Tensor<float> t(4.0);
+    backprop::Tensor<float> t2(5.5);
+    backprop::Tensor<float> t3 = t*t2;
+    backprop::Tensor<float> t4(2.0);
+    backprop::Tensor<float> t5 = t3+t4;
+    backprop::Tensor<float> t6(3.0);
+    backprop::Tensor<float> t7 = t5*t6;
+    backprop::Graph<float> graph(t7);
+
+    EXPECT_EQ(graph.size(), 7);
+    EXPECT_EQ(graph.output, graph.slot(&t7));
+    for(size_t i = 0; i < graph.size(); i++){
+        for(size_t input : graph.nodes[i].inputs){
+            EXPECT_LT(input, i);
+        }
+    }
+    EXPECT_TRUE(graph.nodes[graph.slot(&t)].leaf);
+    EXPECT_FALSE(graph.nodes[graph.slot(&t5)].leaf);
+    EXPECT_EQ(graph.nodes[graph.slot(&t5)].op, backprop::OpType::Add);
+    EXPECT_EQ(graph.nodes[graph.slot(&t7)].op, backprop::OpType::Multiply);
+}
+
+/*
+Compiled version of the DoubleUseBackpropogation graph, gradients must match the interpreter
+((4.0 * 5.5) + (5.5 * -2.0)) * 3.0
+*/
+TEST(CompilerTest, MatchesInterpretedBackward){
+    backprop::Tensor<float> t(4.0);
+    backprop::Tensor<float> t2(5.5);
+    backprop::Tensor<float> t3 = t*t2;
+    backprop::Tensor<float> t4(-2.0);
+    backprop::Tensor<float> t5 = t2 * t4;
+    backprop::Tensor<float> t6 = t3+t5;
+    backprop::Tensor<float> t7(3.0);
+    backprop::Tensor<float> t8 = t7*t6;
+
+    backprop::CompiledGraph<float> compiled(t8);
+    compiled.forward();
+    EXPECT_EQ(t8.item(), 33.0);
+    t8.grad_ = 1.0;
+    compiled.backward();
+
+    EXPECT_EQ(t7.grad_, 11.0);
+    EXPECT_EQ(t6.grad_, 3.0);
+    EXPECT_EQ(t5.grad_, 3.0);
+    EXPECT_EQ(t4.grad_, 16.5);
+    EXPECT_EQ(t3.grad_, 3.0);
+    EXPECT_EQ(t2.grad_, 6.0);
+    EXPECT_EQ(t.grad_, 16.5);
+}
+
+TEST(CompilerTest, ReloadsLeavesOnForward){
+    backprop::Tensor<double> x(0.5);
+    backprop::Tensor<double> w(-1.5);
+    backprop::Tensor<double> xw = x*w;
+    backprop::Tensor<double> b(0.25);
+    backprop::Tensor<double> z = xw+b;
+    backprop::Tensor<double> out = tanh(z);
+
+    backprop::CompiledGraph<double> compiled(out);
+    for(double value : {0.5, -2.0, 3.0}){
+        x.set(value);
+        x.grad_ = 0.0;
+        compiled.forward();
+        EXPECT_NEAR(out.item(), std::tanh(value * -1.5 + 0.25), 1e-12);
+        out.grad_ = 1.0;
+        compiled.backward();
+        double tanh_z = std::tanh(value * -1.5 + 0.25);
+        EXPECT_NEAR(x.grad_, -1.5 * (1 - tanh_z * tanh_z), 1e-12);
+    }
+}
+
+TEST(CompilerTest, TanhMatchesInterpreterForLargeInputs){
+    backprop::Tensor<float> x(100.0);
+    backprop::Tensor<float> out = tanh(x);
+
+    backprop::CompiledGraph<float> compiled(out);
+    for(float value : {100.0f, -100.0f, 0.5f}){
+        x.set(value);
+        out.grad_fn_ptr->forward();
+        float interpreted = out.item();
+        compiled.forward();
+        EXPECT_EQ(out.item(), interpreted);
+    }
+}
+
+TEST(CompilerTest, CompilerIsNotRunThroughShell){
+    backprop::Tensor<float> t(4.0);
+    backprop::Tensor<float> t2(5.5);
+    backprop::Tensor<float> sum = t+t2;
+
+    std::filesystem::path marker = std::filesystem::temp_directory_path() / "backprop_jit_injected";
+    std::filesystem::remove(marker);
+    std::string cxx = "c++; touch " + marker.string();
+    setenv("BACKPROP_JIT_CXX", cxx.c_str(), 1);
+    EXPECT_THROW(backprop::CompiledGraph<float> compiled(sum), std::runtime_error);
+    unsetenv("BACKPROP_JIT_CXX");
+    EXPECT_FALSE(std::filesystem::exists(marker));
+}
+
+TEST(CompilerTest, ConstantsAreLeavesWithoutOptimization){
+    backprop::Tensor<float> t(1.5);
+    backprop::Tensor<float> res = t*2.0f;
+    backprop::Tensor<float> res2 = res+3.0f;
+
+    backprop::CompiledGraph<float> compiled(res2, false);
+    EXPECT_EQ(compiled.graph().size(), 5);
+    t.set(2.5);
+    compiled.forward();
+    EXPECT_EQ(res.item(), 5.0);
+    EXPECT_EQ(res2.item(), 8.0);
+    res2.grad_ = 1.0;
+    compiled.backward();
+    EXPECT_EQ(t.grad_, 2.0);
+    EXPECT_NE(compiled.source().find("bp_backward"), std::string::npos);
+}
+
+TEST(CompilerTest, InlinesConstants){
+    backprop::Tensor<float> t(1.5);
+    backprop::Tensor<float> res = t*2.0f;
+    backprop::Tensor<float> res2 = res+3.0f;
+
+    backprop::CompiledGraph<float> compiled(res2);
+    EXPECT_EQ(compiled.graph().size(), 5);
+    t.set(2.5);
+    compiled.forward();
+    EXPECT_EQ(res.item(), 5.0);
+    EXPECT_EQ(res2.item(), 8.0);
+    EXPECT_EQ(backprop::ConstantRegistry<float>::get_constant(2.0f)->item(), 2.0f);
+    res2.grad_ = 1.0;
+    compiled.backward();
+    EXPECT_EQ(t.grad_, 2.0);
+    EXPECT_NE(compiled.source().find("0x1p+1f"), std::string::npos);
+}
+
+/*
+x*y + tanh(x*y) where x*y was recorded twice, once as y*x
+*/
+TEST(OptimizerTest, SharesCommonSubexpressions){
+    backprop::Tensor<float> x(0.5);
+    backprop::Tensor<float> y(-1.5);
+    backprop::Tensor<float> xy = x*y;
+    backprop::Tensor<float> yx = y*x;
+    backprop::Tensor<float> t = tanh(yx);
+    backprop::Tensor<float> out = xy+t;
+
+    backprop::Graph<float> graph(out);
+    EXPECT_EQ(graph.size(), 6);
+    EXPECT_EQ(graph.optimize(), 1);
+    EXPECT_EQ(graph.size(), 5);
+    EXPECT_TRUE(graph.contains(&xy));
+    EXPECT_FALSE(graph.contains(&yx));
+
+    out.grad_ = 1.0;
+    out.backward();
+    float interpreted_x = x.grad_;
+    float interpreted_y = y.grad_;
+    float interpreted_xy = xy.grad_;
+    float interpreted_yx = yx.grad_;
+    x.grad_ = 0.0;
+    y.grad_ = 0.0;
+    xy.grad_ = 0.0;
+    yx.grad_ = 0.0;
+
+    backprop::CompiledGraph<float> compiled(out);
+    compiled.forward();
+    compiled.backward();
+    EXPECT_NEAR(x.grad_, interpreted_x, 1e-6);
+    EXPECT_NEAR(y.grad_, interpreted_y, 1e-6);
+    // the kept tensor gets the gradient of both uses, the merged away one is untouched
+    EXPECT_NEAR(xy.grad_, interpreted_xy + interpreted_yx, 1e-6);
+    EXPECT_EQ(yx.grad_, 0.0f);
+}
+
+/*
+x*y + (y*x)*w, the merged away y*x must still see new leaf values so the interpreted
+backward pass can run after the compiled forward pass
+*/
+TEST(OptimizerTest, WritesValuesOfMergedTensors){
+    backprop::Tensor<float> x(0.5);
+    backprop::Tensor<float> y(-1.5);
+    backprop::Tensor<float> w(1.0);
+    backprop::Tensor<float> xy = x*y;
+    backprop::Tensor<float> yx = y*x;
+    backprop::Tensor<float> z = yx*w;
+    backprop::Tensor<float> out = xy+z;
+
+    backprop::CompiledGraph<float> compiled(out);
+    EXPECT_FALSE(compiled.graph().contains(&yx));
+    EXPECT_EQ(compiled.graph().aliases().size(), 1);
+    x.set(2.0);
+    compiled.forward();
+    EXPECT_EQ(xy.item(), -3.0f);
+    EXPECT_EQ(yx.item(), -3.0f);
+    EXPECT_EQ(out.item(), -6.0f);
+
+    out.grad_ = 1.0;
+    out.backward();
+    EXPECT_EQ(w.grad_, -3.0f);
+    EXPECT_EQ(x.grad_, -3.0f);
+
+    // the compiled backward pass does not count the alias again
+    yx.grad_ = 0.0;
+    compiled.backward();
+    EXPECT_EQ(yx.grad_, 0.0f);
+    EXPECT_EQ(w.grad_, -6.0f);
+}
+
+TEST(OptimizerTest, FoldsConstantSubgraphs){
+    backprop::Tensor<float> x(0.5);
+    backprop::Tensor<float>& two = *backprop::ConstantRegistry<float>::get_constant(2.0f);
+    backprop::Tensor<float> six = two*3.0f;
+    backprop::Tensor<float> t = tanh(six);
+    backprop::Tensor<float> out = x*t;
+
+    backprop::Graph<float> graph(out);
+    EXPECT_EQ(graph.size(), 6);
+    graph.optimize();
+    // x, the folded tanh(6) and the product
+    EXPECT_EQ(graph.size(), 3);
+    const backprop::GraphNode<float>& product = graph.nodes[graph.output];
+    ASSERT_EQ(product.inputs.size(), 2);
+    const backprop::GraphNode<float>& folded = graph.nodes[product.inputs[1]];
+    EXPECT_TRUE(folded.constant);
+    EXPECT_NEAR(folded.value, std::tanh(6.0f), 1e-6);
+    // folded tensors and constants are no longer bound
+    EXPECT_FALSE(graph.contains(&t));
+    EXPECT_FALSE(graph.contains(&six));
+    EXPECT_FALSE(graph.contains(&two));
+    // the folded tanh(6) is an alias of its constant, 6 itself was removed
+    ASSERT_EQ(graph.aliases().size(), 1);
+    EXPECT_EQ(graph.aliases()[0].first, &t);
+
+    backprop::CompiledGraph<float> compiled(out);
+    x.set(2.0);
+    compiled.forward();
+    EXPECT_NEAR(out.item(), 2.0f * std::tanh(6.0f), 1e-6);
+    out.grad_ = 1.0;
+    compiled.backward();
+    EXPECT_NEAR(x.grad_, std::tanh(6.0f), 1e-6);
+    EXPECT_EQ(t.grad_, 0.0f);
+    EXPECT_EQ(six.grad_, 0.0f);
+}
+
+TEST(OptimizerTest, RewritesNegationIntoSubtraction){
+    backprop::Tensor<float> x(2.5);
+    backprop::Tensor<float> y(1.5);
+    backprop::Tensor<float> negated = y * -1.0f;
+    backprop::Tensor<float> out = x + negated;
+
+    backprop::Graph<float> graph(out);
+    EXPECT_EQ(graph.size(), 5);
+    EXPECT_EQ(graph.optimize(), 2);
+    EXPECT_EQ(graph.nodes[graph.output].op, backprop::OpType::Subtract);
+    EXPECT_FALSE(graph.contains(&negated));
+
+    backprop::CompiledGraph<float> compiled(out);
+    compiled.forward();
+    EXPECT_EQ(out.item(), 1.0f);
+    out.grad_ = 1.5f;
+    compiled.backward();
+    EXPECT_EQ(x.grad_, 1.5f);
+    EXPECT_EQ(y.grad_, -1.5f);
+}
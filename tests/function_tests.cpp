@@ -22,6 +22,20 @@ TEST(FunctionTest, AddFunctionTest){
     // EXPECT_EQ(t2.grad_, 1.5);
 }
 
+TEST(FunctionTest, SubtractFunctionTest){
+    backprop::Tensor<float> t(4.0);
+    backprop::Tensor<float> t2(5.5);
+    backprop::SubtractFunction<float> subtract_fn(&t, &t2);
+    EXPECT_EQ(subtract_fn.parents[0], &t) << "SubtractFunction should have t as parent";
+    EXPECT_EQ(subtract_fn.parents[1], &t2) << "SubtractFunction should have t2 as parent";
+
+    // test backward
+    backprop::Tensor<float> out(-1.5);
+    out.grad_ = 1.0;
+    subtract_fn.set_output_tensor(&out);
+    backprop_function_test(subtract_fn);
+}
+
 TEST(FunctionTest, MultiplyFunctionTest){
     backprop::Tensor<float> t(4.0);
     backprop::Tensor<float> t2(5.5);
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include "backprop/tensor.hpp"
+#include "backprop/memory.hpp"
+#include "backprop/introspection.hpp"
+
+TEST(MemoryTrackerTest, CountsLiveTensorsAndFunctions){
+    backprop::MemorySnapshot before = backprop::MemoryTracker<float>::snapshot();
+    {
+        backprop::Tensor<float> t(4.0);
+        backprop::Tensor<float> t2(5.5);
+        backprop::Tensor<float> sum = t+t2;
+        backprop::MemorySnapshot during = backprop::MemoryTracker<float>::snapshot();
+        EXPECT_EQ(during.live_tensors, before.live_tensors + 3);
+        EXPECT_EQ(during.live_functions, before.live_functions + 1);
+        EXPECT_EQ(during.value_bytes, before.value_bytes + 3 * sizeof(float));
+        EXPECT_EQ(during.grad_bytes, before.grad_bytes + 3 * sizeof(float));
+        EXPECT_EQ(during.saved_bytes, before.saved_bytes + sum.grad_fn_ptr->saved_bytes());
+    }
+    backprop::MemorySnapshot after = backprop::MemoryTracker<float>::snapshot();
+    EXPECT_EQ(after.live_tensors, before.live_tensors);
+    EXPECT_EQ(after.live_functions, before.live_functions);
+    EXPECT_EQ(after.saved_bytes, before.saved_bytes);
+}
+
+TEST(MemoryTrackerTest, StepWithoutRetentionIsClean){
+    backprop::MemoryTracker<double>::begin_step();
+    size_t start = backprop::MemoryTracker<double>::snapshot().total_bytes();
+    {
+        backprop::Tensor<double> t(4.0);
+        backprop::Tensor<double> t2(5.5);
+        backprop::Tensor<double> product = t*t2;
+        backprop::Tensor<double> out = tanh(product);
+        out.grad_ = 1.0;
+        out.backward();
+    }
+    backprop::StepReport report = backprop::MemoryTracker<double>::end_step();
+    EXPECT_FALSE(report.leaked());
+    EXPECT_EQ(report.tensor_delta, 0);
+    EXPECT_EQ(report.byte_delta, 0);
+    EXPECT_GE(report.peak_bytes, start + 4 * 2 * sizeof(double));
+}
+
+TEST(MemoryTrackerTest, NewConstantIsNotALeak){
+    backprop::Tensor<float> x(2.0);
+    backprop::MemoryTracker<float>::begin_step();
+    size_t constants = backprop::MemoryTracker<float>::snapshot().constant_tensors;
+    {
+        // a value no other test uses, so the registry creates it during this step
+        backprop::Tensor<float> y = x * 0.37f;
+    }
+    backprop::StepReport report = backprop::MemoryTracker<float>::end_step();
+    EXPECT_EQ(backprop::MemoryTracker<float>::snapshot().constant_tensors, constants + 1);
+    EXPECT_FALSE(report.leaked());
+    EXPECT_EQ(report.tensor_delta, 0);
+    EXPECT_EQ(report.byte_delta, 0);
+}
+
+TEST(MemoryTrackerTest, DetectsRetainedGraph){
+    std::unique_ptr<backprop::Tensor<double>> retained;
+    backprop::Tensor<double> t(4.0);
+    backprop::Tensor<double> t2(5.5);
+    backprop::MemoryTracker<double>::begin_step();
+    retained.reset(new backprop::Tensor<double>(t*t2));
+    backprop::StepReport report = backprop::MemoryTracker<double>::end_step();
+    EXPECT_TRUE(report.leaked());
+    EXPECT_EQ(report.tensor_delta, 1);
+    EXPECT_EQ(report.function_delta, 1);
+    EXPECT_EQ(report.byte_delta,
+        static_cast<long long>(2 * sizeof(double) + retained->grad_fn_ptr->saved_bytes()));
+}
+
+/*
+Graph is ((4.0 * 5.5) + 2.0) * 3.0, 4 leaves and 3 functions
+*/
+TEST(IntrospectionTest, GraphStats){
+    backprop::Tensor<float> t(4.0);
+    backprop::Tensor<float> t2(5.5);
+    backprop::Tensor<float> t3 = t*t2;
+    backprop::Tensor<float> t4(2.0);
+    backprop::Tensor<float> t5 = t3+t4;
+    backprop::Tensor<float> t6(3.0);
+    backprop::Tensor<float> t7 = t5*t6;
+
+    backprop::GraphStats stats = backprop::graph_stats(t7);
+    EXPECT_EQ(stats.nodes, 7);
+    EXPECT_EQ(stats.leaves, 4);
+    EXPECT_EQ(stats.functions, 3);
+    EXPECT_EQ(stats.value_bytes, 7 * sizeof(float));
+    EXPECT_EQ(stats.grad_bytes, 7 * sizeof(float));
+    EXPECT_EQ(stats.saved_bytes, t3.grad_fn_ptr->saved_bytes() +
+        t5.grad_fn_ptr->saved_bytes() + t7.grad_fn_ptr->saved_bytes());
+}
+
+TEST(IntrospectionTest, DotDump){
+    backprop::Tensor<float> t(4.0);
+    backprop::Tensor<float> t2(5.5);
+    backprop::Tensor<float> t3 = t*t2;
+    backprop::Tensor<float> t4 = t3+1.0f;
+
+    std::ostringstream dot;
+    backprop::to_dot(t4, dot);
+    std::string out = dot.str();
+    EXPECT_EQ(out.rfind("digraph backprop {", 0), 0);
+    EXPECT_NE(out.find("label=\"mul"), std::string::npos);
+    EXPECT_NE(out.find("label=\"add"), std::string::npos);
+    EXPECT_NE(out.find("label=\"const"), std::string::npos);
+    EXPECT_NE(out.find("n0 -> n2;"), std::string::npos);
+    EXPECT_NE(out.find("bytes=" + std::to_string(backprop::node_bytes(t3))), std::string::npos);
+}
@@ -72,6 +72,14 @@ TEST(TEnsorTest, TanhForward){
     nullptr);
 }
 
+TEST(TensorTest, TanhSaturates){
+    backprop::Tensor<float> t(100.0);
+    backprop::Tensor<float> logits = tanh(t);
+    EXPECT_EQ(logits.item(), 1.0f);
+    logits.grad_fn_ptr->forward();
+    EXPECT_EQ(logits.item(), 1.0f);
+}
+
 /*
 Tests creating a chain of operations
 In particular tests: ((4.0 * 5.5) + 2.0) * 3.0
@@ -191,13 +199,15 @@ TEST(TensorTest, AddWithConstants){
   EXPECT_EQ(res2.grad_fn_ptr->parents[1], backprop::ConstantRegistry<float>::get_constant(3.0f));
 }
 
-// TEST(TensorTest, SubtractOp){
-//   backprop::Tensor<float> t(2.5);
-//   backprop::Tensor<float> t2(1.5);
-//   backprop::Tensor<float> res = t-t2;
-//   EXPECT_EQ(res.item(), 1.0f);
-//   res.grad_ = 1.5f;
-//   res.backward();
-//   EXPECT_EQ(t.grad_, 1.5f);
-//   EXPECT_EQ(t2.grad_, -1.5f);
-// }
\ No newline at end of file
+TEST(TensorTest, SubtractOp){
+  backprop::Tensor<float> t(2.5);
+  backprop::Tensor<float> t2(1.5);
+  backprop::Tensor<float> res = t-t2;
+  EXPECT_EQ(res.item(), 1.0f);
+  res.grad_ = 1.5f;
+  res.backward();
+  EXPECT_EQ(t.grad_, 1.5f);
+  EXPECT_EQ(t2.grad_, -1.5f);
+  EXPECT_NE(std::dynamic_pointer_cast<backprop::SubtractFunction<float>>(res.grad_fn_ptr),
+  nullptr);
+}
\ No newline at end of file